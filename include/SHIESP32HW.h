@@ -7,6 +7,7 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <AsyncUDP.h>
+#include <HTTPClient.h>
 #include <Preferences.h>
 #include <WiFi.h>
 
@@ -62,6 +63,15 @@ class ESP32HWConfig : public Configuration {
   int baudRate = 115200;
   bool noSerialLogging = false;
   int debugLevel = 0;
+
+  bool cpuGovernor = false;
+  int loopDeadline = 1000;  // time in ms a loop iteration should take at most
+  int minCpuFrequency = 80;
+
+  int provisioningAttempts = 5;
+  int provisioningStartSpread = 10000;  // max random delay in ms before start
+  int provisioningBackoff = 500;  // base delay in ms, doubled on each retry
+  int provisioningMaxBackoff = 30000;
 };
 
 class SHIPrinter : public Print {
@@ -73,6 +83,7 @@ class SHIPrinter : public Print {
 class HardwareSHIPrinter : public SHI::SHIPrinter {
   void begin(int baudRate) { Serial.begin(baudRate); }
   size_t write(uint8_t data) { return Serial.write(data); }
+  void flush() { Serial.flush(); }
 };
 
 class NullSHIPrinter : public SHI::SHIPrinter {
@@ -114,10 +125,18 @@ class ESP32HW : public Hardware {
   std::vector<std::pair<std::string, std::string>> getStatistics() override;
 
   const Configuration *getConfig() const override { return &hwConfig; }
-  bool reconfigure(Configuration *newConfig) override {
-    hwConfig = castConfig<ESP32HWConfig>(newConfig);
-    return true;
-  }
+  bool reconfigure(Configuration *newConfig) override;
+  // Runs the CPU at the highest frequency for the given time, regardless of
+  // the load the governor measured
+  void boostCpu(uint32_t durationMs);
+  // GETs the url from the provisioning server. The first request after boot
+  // is spread with a random start delay and failed requests are retried with
+  // jittered exponential backoff, so that a fleet rebooting at once doesn't
+  // hit the server all at the same time.
+  // Returns the last HTTP code, the body can be fetched from http.
+  int provisioningGet(HTTPClient &http, const String &url);
+  // Location of the runtime configuration of this node: <baseURL><name>.json
+  String getRuntimeConfigURL();
   void logInfo(const std::string &name, const char *func,
                const String &message) {
     if (hwConfig.debugLevel <= 0)
@@ -154,6 +173,15 @@ class ESP32HW : public Hardware {
   void setupWifiFromConfig(const std::string &defaultName);
   void initialWifiConnect();
   void storeWifiConfig();
+  void storeWifiAddress();
+  void reconfigureLogging(const ESP32HWConfig &newConfig);
+  void reconfigureWifi(const ESP32HWConfig &newConfig);
+  void applyDNS();
+  void governCpuFrequency(uint32_t loopDuration);
+  void setCpuFrequencyLevel(size_t level);
+  uint32_t cpuFrequencyOfLevel(size_t level);
+  void startBoost(uint32_t durationMs);
+  void provisioningDelay(uint32_t maxDelay);
 
   void wifiDisconnected(WiFiEventInfo_t info);
   void wifiConnected();
@@ -163,9 +191,23 @@ class ESP32HW : public Hardware {
   config_t config;
   hw_timer_t *timer = NULL;
   int connectCount = 0, retryCount = 0;
+  uint32_t reconnectDeadline = 0;
   uint32_t sensorSetupTime = 0, initialWifiConnectTime = 0, commSetupTime = 0;
   float averageSensorLoopDuration = 0, averageConnectDuration = 0;
   std::string internalStatus = SHI::STATUS_OK;
+
+  static const size_t CPU_LEVELS = 3;
+  static const uint32_t CPU_FREQUENCIES[CPU_LEVELS];
+  // Level CPU_LEVELS stands for a boot frequency not in CPU_FREQUENCIES
+  size_t cpuLevel = 0, bootLevel = 0;
+  uint32_t bootFrequency = 0;
+  int lowLoadCount = 0;
+  uint32_t boostUntil = 0, lastFrequencyChange = 0;
+  uint32_t timeAtFrequency[CPU_LEVELS + 1] = {0};
+  uint32_t deadlineMisses = 0, frequencyChanges = 0;
+  uint32_t provisioningRequests = 0, provisioningRetries = 0;
+  uint32_t provisioningTime = 0;
+  bool provisioningSpread = false;
 };
 
 }  // namespace SHI
@@ -9,5 +9,13 @@
 #include <FS.h>
 #include <SHIFactory.h>
 
+namespace SHI {
+class ESP32HW;
+}  // namespace SHI
+
 SHI::FactoryErrors bootstrapFromConfig(const FS &fs, const char *filename);
 bool writeConfigFile(const FS &fs, const char *filename, String content);
+// Downloads the runtime config of the node from the provisioning server and
+// stores it in filename. Returns true if the file was written.
+bool provisionRuntimeConfig(SHI::ESP32HW *hw, const FS &fs,
+                            const char *filename);
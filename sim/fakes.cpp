@@ -0,0 +1,473 @@
+/*
+ * Copyright (c) 2020 Karsten Becker All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ */
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <FS.h>
+#include <Preferences.h>
+#include <SPIFFS.h>
+#include <WiFi.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdarg>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "fleet_sim.h"
+
+namespace {
+
+const std::chrono::steady_clock::time_point BOOT =
+    std::chrono::steady_clock::now();
+
+std::string numberToString(unsigned long long value, unsigned char base) {
+  if (value == 0) return "0";
+  std::string result;
+  while (value > 0) {
+    result += "0123456789abcdefghijklmnopqrstuvwxyz"[value % base];
+    value /= base;
+  }
+  std::reverse(result.begin(), result.end());
+  return result;
+}
+
+std::string numberToString(long long value, unsigned char base) {
+  if (value < 0)
+    return "-" + numberToString(static_cast<unsigned long long>(-value), base);
+  return numberToString(static_cast<unsigned long long>(value), base);
+}
+
+std::string floatToString(double value, unsigned int decimalPlaces) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+  return buf;
+}
+
+}  // namespace
+
+thread_local sim::Node *sim::node = nullptr;
+thread_local WiFiClass WiFi;
+HardwareSerial Serial;
+EspClass ESP;
+fs::SPIFFSFS SPIFFS;
+
+String::String(unsigned char value, unsigned char base)
+    : buffer(numberToString(static_cast<unsigned long long>(value), base)) {}
+String::String(int value, unsigned char base)
+    : buffer(numberToString(static_cast<long long>(value), base)) {}
+String::String(unsigned int value, unsigned char base)
+    : buffer(numberToString(static_cast<unsigned long long>(value), base)) {}
+String::String(long value, unsigned char base)
+    : buffer(numberToString(static_cast<long long>(value), base)) {}
+String::String(unsigned long value, unsigned char base)
+    : buffer(numberToString(static_cast<unsigned long long>(value), base)) {}
+String::String(float value, unsigned int decimalPlaces)
+    : buffer(floatToString(value, decimalPlaces)) {}
+String::String(double value, unsigned int decimalPlaces)
+    : buffer(floatToString(value, decimalPlaces)) {}
+
+void String::replace(char find, char replace) {
+  std::replace(buffer.begin(), buffer.end(), find, replace);
+}
+
+void String::replace(const String &find, const String &replace) {
+  if (find.buffer.empty()) return;
+  size_t pos = 0;
+  while ((pos = buffer.find(find.buffer, pos)) != std::string::npos) {
+    buffer.replace(pos, find.buffer.length(), replace.buffer);
+    pos += replace.buffer.length();
+  }
+}
+
+void String::trim() {
+  auto notSpace = [](char c) {
+    return !isspace(static_cast<unsigned char>(c));
+  };
+  buffer.erase(buffer.begin(),
+               std::find_if(buffer.begin(), buffer.end(), notSpace));
+  buffer.erase(std::find_if(buffer.rbegin(), buffer.rend(), notSpace).base(),
+               buffer.end());
+}
+
+void String::toCharArray(char *buf, unsigned int bufsize) const {
+  if (bufsize == 0) return;
+  size_t len = std::min<size_t>(buffer.length(), bufsize - 1);
+  memcpy(buf, buffer.data(), len);
+  buf[len] = 0;
+}
+
+namespace {
+
+int toIndex(size_t pos) {
+  return pos == std::string::npos ? -1 : static_cast<int>(pos);
+}
+
+std::string lowerCase(std::string str) {
+  for (auto &&c : str) c = tolower(static_cast<unsigned char>(c));
+  return str;
+}
+
+}  // namespace
+
+int String::indexOf(char c, unsigned int fromIndex) const {
+  return toIndex(buffer.find(c, fromIndex));
+}
+
+int String::indexOf(const String &str, unsigned int fromIndex) const {
+  return toIndex(buffer.find(str.buffer, fromIndex));
+}
+
+int String::lastIndexOf(char c) const { return toIndex(buffer.rfind(c)); }
+
+int String::lastIndexOf(const String &str) const {
+  return toIndex(buffer.rfind(str.buffer));
+}
+
+bool String::equalsIgnoreCase(const String &s) const {
+  return lowerCase(buffer) == lowerCase(s.buffer);
+}
+
+bool String::startsWith(const String &prefix) const {
+  return buffer.compare(0, prefix.buffer.length(), prefix.buffer) == 0;
+}
+
+bool String::endsWith(const String &suffix) const {
+  return buffer.length() >= suffix.buffer.length() &&
+         buffer.compare(buffer.length() - suffix.buffer.length(),
+                        suffix.buffer.length(), suffix.buffer) == 0;
+}
+
+char String::charAt(unsigned int index) const {
+  return index < buffer.length() ? buffer[index] : 0;
+}
+
+void String::setCharAt(unsigned int index, char c) {
+  if (index < buffer.length()) buffer[index] = c;
+}
+
+void String::remove(unsigned int index) {
+  if (index < buffer.length()) buffer.erase(index);
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+  if (index < buffer.length()) buffer.erase(index, count);
+}
+
+void String::toLowerCase() { buffer = lowerCase(buffer); }
+
+void String::toUpperCase() {
+  for (auto &&c : buffer) c = toupper(static_cast<unsigned char>(c));
+}
+
+String String::substring(unsigned int beginIndex) const {
+  return substring(beginIndex, length());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+  if (beginIndex >= buffer.length() || endIndex <= beginIndex) return String();
+  return String(buffer.substr(beginIndex, endIndex - beginIndex));
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) n += write(*buffer++);
+  return n;
+}
+
+size_t Print::printf(const char *format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len < 0) return 0;
+  return write(reinterpret_cast<const uint8_t *>(buf),
+               std::min<size_t>(len, sizeof(buf) - 1));
+}
+
+size_t HardwareSerial::write(uint8_t data) {
+  return fputc(data, stderr) != EOF;
+}
+void HardwareSerial::flush() { fflush(stderr); }
+
+bool IPAddress::fromString(const char *str) {
+  struct in_addr addr;
+  if (inet_pton(AF_INET, str, &addr) != 1) return false;
+  address = addr.s_addr;
+  return true;
+}
+
+String IPAddress::toString() const {
+  char buf[INET_ADDRSTRLEN];
+  struct in_addr addr;
+  addr.s_addr = address;
+  inet_ntop(AF_INET, &addr, buf, sizeof(buf));
+  return String(buf);
+}
+
+void EspClass::restart() { throw sim::Restart(); }
+void esp_restart() { ESP.restart(); }
+
+unsigned long millis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - BOOT)
+      .count();
+}
+
+void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  std::uniform_int_distribution<long> dist(howsmall, howbig - 1);
+  return dist(sim::node->rng);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+void digitalWrite(uint8_t pin, uint8_t val) {}
+
+uint32_t getCpuFrequencyMhz() { return sim::node->cpuFrequency; }
+bool setCpuFrequencyMhz(uint32_t cpu_freq_mhz) {
+  sim::node->cpuFrequency = cpu_freq_mhz;
+  return true;
+}
+
+void configTime(long gmtOffset_sec, int daylightOffset_sec,
+                const char *server1, const char *server2,
+                const char *server3) {}
+
+hw_timer_t *timerBegin(uint8_t timer, uint16_t divider, bool countUp) {
+  static thread_local hw_timer_t timers[4];
+  return &timers[timer % 4];
+}
+void timerEnd(hw_timer_t *timer) { timer->enabled = false; }
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge) {}
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarm_value, bool autoreload) {
+  timer->alarm = alarm_value;
+}
+void timerAlarmEnable(hw_timer_t *timer) { timer->enabled = true; }
+void timerWrite(hw_timer_t *timer, uint64_t val) {}
+
+void WiFiClass::onEvent(WiFiEventFuncCb cb, WiFiEvent_t event) {
+  handlers.push_back(std::make_pair(event, cb));
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *passphrase) {
+  associating = true;
+  connected = false;
+  associatedAt = millis() + sim::node->associationTime;
+  return WL_DISCONNECTED;
+}
+
+bool WiFiClass::config(IPAddress local_ip, IPAddress gateway, IPAddress subnet,
+                       IPAddress dns1, IPAddress dns2) {
+  staticIP = local_ip;
+  return true;
+}
+
+bool WiFiClass::disconnect() {
+  bool wasConnected = connected;
+  associating = connected = false;
+  if (wasConnected) fire(SYSTEM_EVENT_STA_DISCONNECTED);
+  return true;
+}
+
+bool WiFiClass::mode(wifi_mode_t mode) {
+  if (mode == WIFI_OFF) disconnect();
+  return true;
+}
+
+wl_status_t WiFiClass::status() {
+  if (associating && static_cast<int32_t>(millis() - associatedAt) >= 0) {
+    associating = false;
+    connected = true;
+    fire(SYSTEM_EVENT_STA_CONNECTED);
+    fire(SYSTEM_EVENT_STA_GOT_IP);
+  }
+  return connected ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+String WiFiClass::macAddress() { return String(sim::node->mac); }
+
+IPAddress WiFiClass::localIP() {
+  if (staticIP != 0) return IPAddress(staticIP);
+  return IPAddress(10, 0, (sim::node->id >> 8) & 0xFF, sim::node->id & 0xFF);
+}
+
+void WiFiClass::reset() {
+  handlers.clear();
+  associating = connected = false;
+  staticIP = 0;
+}
+
+void WiFiClass::fire(WiFiEvent_t event) {
+  WiFiEventInfo_t info = {};
+  // Copy, a handler might register further handlers
+  auto current = handlers;
+  for (auto &&handler : current) {
+    if (handler.first == SYSTEM_EVENT_MAX || handler.first == event)
+      handler.second(event, info);
+  }
+}
+
+bool Preferences::begin(const char *name, bool readOnly) {
+  nameSpace = name;
+  return true;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len) {
+  auto data = static_cast<const uint8_t *>(value);
+  sim::node->nvs[nameSpace + "/" + key].assign(data, data + len);
+  return len;
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+  auto it = sim::node->nvs.find(nameSpace + "/" + key);
+  if (it == sim::node->nvs.end()) return 0;
+  size_t len = std::min(maxLen, it->second.size());
+  memcpy(buf, it->second.data(), len);
+  return len;
+}
+
+size_t fs::File::write(uint8_t data) {
+  if (content == nullptr) {
+    setWriteError();
+    return 0;
+  }
+  content->push_back(data);
+  return 1;
+}
+
+String fs::File::readString() {
+  if (content == nullptr || position >= content->length()) return String();
+  String result(content->substr(position));
+  position = content->length();
+  return result;
+}
+
+fs::File fs::FS::open(const char *path, const char *mode) const {
+  auto &files = sim::node->files;
+  if (mode[0] == 'w') {
+    files[path].clear();
+    return File(&files[path]);
+  }
+  auto it = files.find(path);
+  if (it == files.end()) return File();
+  return File(&it->second);
+}
+
+bool fs::FS::exists(const char *path) const {
+  return sim::node->files.count(path) != 0;
+}
+
+bool fs::FS::remove(const char *path) const {
+  return sim::node->files.erase(path) != 0;
+}
+
+bool HTTPClient::begin(const String &url) {
+  std::string str(url.c_str());
+  const std::string scheme = "http://";
+  if (str.compare(0, scheme.length(), scheme) != 0) return false;
+  str = str.substr(scheme.length());
+  size_t slash = str.find('/');
+  std::string hostPort = str.substr(0, slash);
+  path = slash == std::string::npos ? "/" : str.substr(slash);
+  size_t colon = hostPort.find(':');
+  host = hostPort.substr(0, colon);
+  port = colon == std::string::npos ? 80 : atoi(hostPort.c_str() + colon + 1);
+  body = String();
+  return true;
+}
+
+void HTTPClient::end() { body = String(); }
+
+int HTTPClient::GET() {
+  uint32_t start = millis();
+  int httpCode = request();
+  sim::recordRequest(start, millis() - start, httpCode);
+  return httpCode;
+}
+
+int HTTPClient::request() {
+  struct addrinfo hints = {}, *addr = nullptr;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host.c_str(), String(port).c_str(), &hints, &addr) != 0)
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  int fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+  if (fd < 0) {
+    freeaddrinfo(addr);
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  int res = connect(fd, addr->ai_addr, addr->ai_addrlen);
+  freeaddrinfo(addr);
+  struct pollfd pfd = {fd, POLLOUT, 0};
+  int err = 0;
+  socklen_t errLen = sizeof(err);
+  if (res != 0 &&
+      (errno != EINPROGRESS || poll(&pfd, 1, connectTimeout) != 1 ||
+       getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errLen) != 0 || err != 0)) {
+    close(fd);
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+  std::string req = "GET " + std::string(path.c_str()) +
+                    " HTTP/1.0\r\nHost: " + host.c_str() +
+                    "\r\nConnection: close\r\n\r\n";
+  if (send(fd, req.data(), req.length(), MSG_NOSIGNAL) !=
+      static_cast<ssize_t>(req.length())) {
+    close(fd);
+    return HTTPC_ERROR_SEND_HEADER_FAILED;
+  }
+  std::string response;
+  char buf[1024];
+  pfd.events = POLLIN;
+  while (true) {
+    if (poll(&pfd, 1, timeout) != 1) {
+      close(fd);
+      return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n < 0) {
+      close(fd);
+      return HTTPC_ERROR_CONNECTION_LOST;
+    }
+    if (n == 0) break;
+    response.append(buf, n);
+  }
+  close(fd);
+  size_t headerEnd = response.find("\r\n\r\n");
+  size_t codeStart = response.find(' ');
+  if (headerEnd == std::string::npos || codeStart == std::string::npos)
+    return HTTPC_ERROR_CONNECTION_LOST;
+  body = String(response.substr(headerEnd + 4));
+  return atoi(response.c_str() + codeStart + 1);
+}
+
+String HTTPClient::errorToString(int error) {
+  switch (error) {
+    case HTTPC_ERROR_CONNECTION_REFUSED:
+      return String("connection refused");
+    case HTTPC_ERROR_SEND_HEADER_FAILED:
+      return String("send header failed");
+    case HTTPC_ERROR_NOT_CONNECTED:
+      return String("not connected");
+    case HTTPC_ERROR_CONNECTION_LOST:
+      return String("connection lost");
+    case HTTPC_ERROR_READ_TIMEOUT:
+      return String("read Timeout");
+    default:
+      return String();
+  }
+}
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2020 Karsten Becker All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ */
+#pragma once
+// Minimal host replacement of the Arduino-ESP32 core, just enough to run
+// SHIESP32HW in the fleet simulator. Everything that is per device (WiFi,
+// NVS, clock speed) lives in the thread local sim::Node of the calling thread.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <string>
+#include <type_traits>
+
+#define IRAM_ATTR
+#define BUILTIN_LED -1
+#define OUTPUT 0x02
+#define HIGH 0x1
+#define LOW 0x0
+
+#define ets_printf printf
+
+class String {
+ public:
+  String() {}
+  String(const char *str) : buffer(str == nullptr ? "" : str) {}  // NOLINT
+  String(const std::string &str) : buffer(str) {}                 // NOLINT
+  explicit String(char c) : buffer(1, c) {}
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);           // NOLINT
+  explicit String(unsigned long value, unsigned char base = 10);  // NOLINT
+  explicit String(float value, unsigned int decimalPlaces = 2);
+  explicit String(double value, unsigned int decimalPlaces = 2);
+
+  const char *c_str() const { return buffer.c_str(); }
+  unsigned int length() const { return buffer.length(); }
+  bool isEmpty() const { return buffer.empty(); }
+  bool reserve(unsigned int size) {
+    buffer.reserve(size);
+    return true;
+  }
+
+  bool concat(const String &str) {
+    buffer += str.buffer;
+    return true;
+  }
+  bool concat(const char *str) { return concat(String(str)); }
+  bool concat(char c) { return concat(String(c)); }
+  bool concat(int num) { return concat(String(num)); }
+  bool concat(unsigned int num) { return concat(String(num)); }
+  bool concat(long num) { return concat(String(num)); }           // NOLINT
+  bool concat(unsigned long num) { return concat(String(num)); }  // NOLINT
+  bool concat(float num) { return concat(String(num)); }
+  bool concat(double num) { return concat(String(num)); }
+  template <typename T>
+  String &operator+=(const T &rhs) {
+    concat(rhs);
+    return *this;
+  }
+
+  int compareTo(const String &s) const { return buffer.compare(s.buffer); }
+  bool equals(const String &s) const { return buffer == s.buffer; }
+  bool equals(const char *s) const { return buffer == s; }
+  bool equalsIgnoreCase(const String &s) const;
+  bool startsWith(const String &prefix) const;
+  bool endsWith(const String &suffix) const;
+  bool operator==(const String &rhs) const { return equals(rhs); }
+  bool operator==(const char *rhs) const { return equals(rhs); }
+  bool operator!=(const String &rhs) const { return !equals(rhs); }
+  bool operator!=(const char *rhs) const { return !equals(rhs); }
+  bool operator<(const String &rhs) const { return compareTo(rhs) < 0; }
+  bool operator>(const String &rhs) const { return compareTo(rhs) > 0; }
+
+  char charAt(unsigned int index) const;
+  void setCharAt(unsigned int index, char c);
+  char operator[](unsigned int index) const { return charAt(index); }
+  char &operator[](unsigned int index) { return buffer[index]; }
+  void getBytes(unsigned char *buf, unsigned int bufsize) const {
+    toCharArray(reinterpret_cast<char *>(buf), bufsize);
+  }
+  void toCharArray(char *buf, unsigned int bufsize) const;
+
+  int indexOf(char c, unsigned int fromIndex = 0) const;
+  int indexOf(const String &str, unsigned int fromIndex = 0) const;
+  int lastIndexOf(char c) const;
+  int lastIndexOf(const String &str) const;
+  String substring(unsigned int beginIndex) const;
+  String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+  void replace(char find, char replace);
+  void replace(const String &find, const String &replace);
+  void remove(unsigned int index);
+  void remove(unsigned int index, unsigned int count);
+  void toLowerCase();
+  void toUpperCase();
+  void trim();
+
+  long toInt() const { return atol(buffer.c_str()); }  // NOLINT
+  float toFloat() const { return atof(buffer.c_str()); }
+  double toDouble() const { return atof(buffer.c_str()); }
+
+ private:
+  std::string buffer;
+};
+
+// Only for a String on the left, std::string + char * must stay std::string
+template <typename S, typename T,
+          typename = typename std::enable_if<
+              std::is_same<S, String>::value>::type>
+String operator+(const S &lhs, const T &rhs) {
+  String result(lhs);
+  result += rhs;
+  return result;
+}
+inline String operator+(const char *lhs, const String &rhs) {
+  String result(lhs);
+  result += rhs;
+  return result;
+}
+inline String operator+(char lhs, const String &rhs) {
+  String result(lhs);
+  result += rhs;
+  return result;
+}
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) {
+    return write(reinterpret_cast<const uint8_t *>(str), strlen(str));
+  }
+  virtual void flush() {}
+  size_t printf(const char *format, ...)
+      __attribute__((format(printf, 2, 3)));
+
+  size_t print(const char *str) { return write(str); }
+  size_t print(const String &str) { return write(str.c_str()); }
+  size_t print(const std::string &str) { return write(str.c_str()); }
+  size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+  size_t print(unsigned char num, int base = 10) {
+    return print(String(num, base));
+  }
+  size_t print(int num, int base = 10) { return print(String(num, base)); }
+  size_t print(unsigned int num, int base = 10) {
+    return print(String(num, base));
+  }
+  size_t print(long num, int base = 10) {  // NOLINT
+    return print(String(num, base));
+  }
+  size_t print(unsigned long num, int base = 10) {  // NOLINT
+    return print(String(num, base));
+  }
+  size_t print(double num, int digits = 2) {
+    return print(String(num, digits));
+  }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T &value) {
+    size_t n = print(value);
+    return n + println();
+  }
+  template <typename T>
+  size_t println(const T &value, int format) {
+    size_t n = print(value, format);
+    return n + println();
+  }
+
+  int getWriteError() { return writeError; }
+  void clearWriteError() { writeError = 0; }
+
+ protected:
+  void setWriteError(int err = 1) { writeError = err; }
+
+ private:
+  int writeError = 0;
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() { return 0; }
+  virtual int read() { return -1; }
+  virtual int peek() { return -1; }
+  void setTimeout(unsigned long timeout) {}  // NOLINT
+  String readString() {
+    String result;
+    int c;
+    while ((c = read()) >= 0) result += static_cast<char>(c);
+    return result;
+  }
+};
+
+class HardwareSerial : public Stream {
+ public:
+  void begin(unsigned long baud) {}  // NOLINT
+  size_t write(uint8_t data) override;
+  void flush() override;
+};
+extern HardwareSerial Serial;
+
+class IPAddress {
+ public:
+  IPAddress() {}
+  IPAddress(uint32_t address) : address(address) {}  // NOLINT
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+      : address(a | (b << 8) | (c << 16) | (static_cast<uint32_t>(d) << 24)) {}
+  bool fromString(const char *address);
+  String toString() const;
+  operator uint32_t() const { return address; }
+
+ private:
+  uint32_t address = 0;
+};
+
+class EspClass {
+ public:
+  // Unwinds the simulated node with a sim::Restart
+  [[noreturn]] void restart();
+};
+extern EspClass ESP;
+[[noreturn]] void esp_restart();
+
+unsigned long millis();  // NOLINT
+void delay(uint32_t ms);
+long random(long howsmall, long howbig);  // NOLINT
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+
+uint32_t getCpuFrequencyMhz();
+bool setCpuFrequencyMhz(uint32_t cpu_freq_mhz);
+
+void configTime(long gmtOffset_sec, int daylightOffset_sec,  // NOLINT
+                const char *server1, const char *server2 = nullptr,
+                const char *server3 = nullptr);
+
+struct hw_timer_t {
+  uint64_t alarm = 0;
+  bool enabled = false;
+};
+hw_timer_t *timerBegin(uint8_t timer, uint16_t divider, bool countUp);
+void timerEnd(hw_timer_t *timer);
+void timerAttachInterrupt(hw_timer_t *timer, void (*fn)(void), bool edge);
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarm_value, bool autoreload);
+void timerAlarmEnable(hw_timer_t *timer);
+void timerWrite(hw_timer_t *timer, uint64_t val);
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2020 Karsten Becker All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ */
+#pragma once
+#include <Arduino.h>
+
+#include <functional>
+
+// The simulated nodes have no UDP, packets are dropped and nothing arrives
+class AsyncUDPPacket : public Print {
+ public:
+  uint8_t *data() { return nullptr; }
+  size_t length() { return 0; }
+  IPAddress remoteIP() { return IPAddress(); }
+  uint16_t remotePort() { return 0; }
+  size_t write(uint8_t data) override { return 1; }
+};
+
+typedef std::function<void(AsyncUDPPacket &packet)> AuPacketHandlerFunction;
+
+class AsyncUDP : public Print {
+ public:
+  void onPacket(AuPacketHandlerFunction cb) {}
+  bool listen(uint16_t port) { return true; }
+  bool listenMulticast(const IPAddress addr, uint16_t port) { return true; }
+  bool connect(const IPAddress addr, uint16_t port) { return true; }
+  void close() {}
+  size_t writeTo(const uint8_t *data, size_t len, const IPAddress addr,
+                 uint16_t port) {
+    return len;
+  }
+  size_t broadcastTo(uint8_t *data, size_t len, uint16_t port) { return len; }
+  size_t broadcastTo(const char *data, uint16_t port) { return strlen(data); }
+  size_t broadcast(uint8_t *data, size_t len) { return len; }
+  size_t broadcast(const char *data) { return strlen(data); }
+  size_t write(const uint8_t *data, size_t len) override { return len; }
+  size_t write(uint8_t data) override { return 1; }
+  bool connected() { return false; }
+};
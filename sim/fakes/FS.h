@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2020 Karsten Becker All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ */
+#pragma once
+#include <Arduino.h>
+
+#include <string>
+
+namespace fs {
+
+// Handle to a file in the flash of the simulated node
+class File : public Print {
+ public:
+  File() {}
+  explicit File(std::string *content) : content(content) {}
+  size_t write(uint8_t data) override;
+  String readString();
+  void close() { content = nullptr; }
+  operator bool() const { return content != nullptr; }
+
+ private:
+  std::string *content = nullptr;
+  size_t position = 0;
+};
+
+class FS {
+ public:
+  virtual ~FS() {}
+  File open(const char *path, const char *mode = "r") const;
+  bool exists(const char *path) const;
+  bool remove(const char *path) const;
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2020 Karsten Becker All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ */
+#pragma once
+#include <Arduino.h>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+// Plain HTTP/1.0 GET over a blocking socket. Every request is recorded in
+// the simulator statistics.
+class HTTPClient {
+ public:
+  bool begin(const String &url);
+  void end();
+  void setConnectTimeout(int32_t connectTimeout) {
+    this->connectTimeout = connectTimeout;
+  }
+  void setTimeout(uint16_t timeout) { this->timeout = timeout; }
+  int GET();
+  String getString() { return body; }
+  static String errorToString(int error);
+
+ private:
+  int request();
+
+  String host, path;
+  uint16_t port = 80;
+  int32_t connectTimeout = 5000;
+  uint16_t timeout = 5000;
+  String body;
+};
@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2020 Karsten Becker All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ */
+#pragma once
+#include <Arduino.h>
+
+#include <string>
+
+// Stores into the NVS of the simulated node, which survives restarts
+class Preferences {
+ public:
+  bool begin(const char *name, bool readOnly = false);
+  void end() {}
+  size_t putBytes(const char *key, const void *value, size_t len);
+  size_t getBytes(const char *key, void *buf, size_t maxLen);
+
+ private:
+  std::string nameSpace;
+};
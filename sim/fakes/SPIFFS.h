@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2020 Karsten Becker All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ */
+#pragma once
+#include <FS.h>
+
+namespace fs {
+
+class SPIFFSFS : public FS {
+ public:
+  bool begin(bool formatOnFail = false) { return true; }
+};
+
+}  // namespace fs
+
+extern fs::SPIFFSFS SPIFFS;
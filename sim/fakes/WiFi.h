@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2020 Karsten Becker All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ */
+#pragma once
+#include <Arduino.h>
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+enum wl_status_t {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+};
+
+enum wifi_mode_t { WIFI_OFF = 0, WIFI_STA = 1 };
+
+enum WiFiEvent_t {
+  SYSTEM_EVENT_STA_CONNECTED = 4,
+  SYSTEM_EVENT_STA_DISCONNECTED = 5,
+  SYSTEM_EVENT_STA_GOT_IP = 7,
+  SYSTEM_EVENT_STA_LOST_IP = 8,
+  SYSTEM_EVENT_MAX = 27
+};
+
+struct WiFiEventInfo_t {
+  struct {
+    uint8_t reason;
+  } disconnected;
+};
+
+// One radio per simulated node, the association completes after the
+// node's configured association time has passed
+class WiFiClass {
+ public:
+  typedef std::function<void(WiFiEvent_t, WiFiEventInfo_t)> WiFiEventFuncCb;
+
+  void onEvent(WiFiEventFuncCb cb, WiFiEvent_t event = SYSTEM_EVENT_MAX);
+  wl_status_t begin(const char *ssid, const char *passphrase);
+  bool config(IPAddress local_ip, IPAddress gateway, IPAddress subnet,
+              IPAddress dns1 = 0u, IPAddress dns2 = 0u);
+  bool disconnect();
+  bool mode(wifi_mode_t mode);
+  bool setHostname(const char *hostname) { return true; }
+  wl_status_t status();
+
+  String macAddress();
+  IPAddress localIP();
+  IPAddress gatewayIP() { return IPAddress(192, 168, 188, 1); }
+  IPAddress subnetMask() { return IPAddress(255, 255, 255, 0); }
+
+  // Forgets all handlers and connections, used when a node restarts
+  void reset();
+
+ private:
+  void fire(WiFiEvent_t event);
+
+  std::vector<std::pair<WiFiEvent_t, WiFiEventFuncCb>> handlers;
+  bool associating = false, connected = false;
+  uint32_t associatedAt = 0;
+  uint32_t staticIP = 0;
+};
+
+extern thread_local WiFiClass WiFi;
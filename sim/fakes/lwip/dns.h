@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2020 Karsten Becker All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ */
+#pragma once
+#include <stdint.h>
+
+#define IPADDR_TYPE_V4 0U
+
+struct ip4_addr_t {
+  uint32_t addr;
+};
+struct ip_addr_t {
+  union {
+    ip4_addr_t ip4;
+  } u_addr;
+  uint8_t type;
+};
+
+inline void dns_setserver(uint8_t numdns, const ip_addr_t *dnsserver) {}
@@ -0,0 +1,9 @@
+/*
+ * Copyright (c) 2020 Karsten Becker All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ */
+#pragma once
+
+// Every simulated node boots as if power was just restored
+inline int rtc_get_reset_reason(int cpu_no) { return 1; }  // POWERON_RESET
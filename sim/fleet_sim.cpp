@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2020 Karsten Becker All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ */
+// Boots a fleet of ESP32HW instances at once, as after a power outage, and
+// drives them through the real setup and provisioning code against an HTTP
+// server. Each node runs in its own thread with its own fake WiFi, NVS and
+// SPIFFS. A fresh node looks up its name, downloads and writes its runtime
+// config, restarts and counts as ready once it booted from that file.
+//
+//   python3 sim/provisioning_server.py --port 8080 &
+//   pio run -e native && .pio/build/native/program --nodes 200
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <SPIFFS.h>
+#include <WiFi.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SHIESP32HW.h"
+#include "SHISPIFFLoader.h"
+#include "fleet_sim.h"
+
+namespace {
+
+const char *RUNTIME_NAME = "/runtime.json";
+
+struct Options {
+  int nodes = 100;
+  std::string baseURL = "http://127.0.0.1:8080/esp/";
+  int bootJitter = 200;
+  int associationMin = 500;
+  int associationMax = 3000;
+  int maxRestarts = 3;
+  unsigned seed = 1;
+  bool verbose = false;
+  SHI::ESP32HWConfig config;
+};
+
+struct Request {
+  uint32_t start, latency;
+  int httpCode;
+};
+
+struct NodeResult {
+  bool ready = false;
+  uint32_t timeToReady = 0;
+  int restarts = 0;
+  uint32_t retries = 0;
+};
+
+std::mutex requestMutex;
+std::vector<Request> requests;
+
+void usage(const char *prog) {
+  printf(
+      "Usage: %s [options]\n"
+      "  --nodes N               simulated nodes (100)\n"
+      "  --url URL               provisioning baseURL "
+      "(http://127.0.0.1:8080/esp/)\n"
+      "  --boot-jitter MS        max power-on skew between nodes (200)\n"
+      "  --association MIN MAX   WiFi association time range (500 3000)\n"
+      "  --max-restarts N        restarts before a node counts as failed,\n"
+      "                          including the one after provisioning (3)\n"
+      "  --seed N                random seed (1)\n"
+      "  --spread MS             provisioningStartSpread\n"
+      "  --attempts N            provisioningAttempts\n"
+      "  --backoff MS            provisioningBackoff\n"
+      "  --max-backoff MS        provisioningMaxBackoff\n"
+      "  --connect-timeout MS    CONNECT_TIMEOUT\n"
+      "  --data-timeout MS       DATA_TIMEOUT\n"
+      "  --verbose               log every node to stderr\n",
+      prog);
+  exit(1);
+}
+
+Options parseOptions(int argc, char **argv) {
+  Options opts;
+  opts.config.noSerialLogging = true;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto next = [&]() -> const char * {
+      if (i + 1 >= argc) usage(argv[0]);
+      return argv[++i];
+    };
+    if (arg == "--nodes") {
+      opts.nodes = atoi(next());
+    } else if (arg == "--url") {
+      opts.baseURL = next();
+    } else if (arg == "--boot-jitter") {
+      opts.bootJitter = atoi(next());
+    } else if (arg == "--association") {
+      opts.associationMin = atoi(next());
+      opts.associationMax = atoi(next());
+    } else if (arg == "--max-restarts") {
+      opts.maxRestarts = atoi(next());
+    } else if (arg == "--seed") {
+      opts.seed = atoi(next());
+    } else if (arg == "--spread") {
+      opts.config.provisioningStartSpread = atoi(next());
+    } else if (arg == "--attempts") {
+      opts.config.provisioningAttempts = atoi(next());
+    } else if (arg == "--backoff") {
+      opts.config.provisioningBackoff = atoi(next());
+    } else if (arg == "--max-backoff") {
+      opts.config.provisioningMaxBackoff = atoi(next());
+    } else if (arg == "--connect-timeout") {
+      opts.config.CONNECT_TIMEOUT = atoi(next());
+    } else if (arg == "--data-timeout") {
+      opts.config.DATA_TIMEOUT = atoi(next());
+    } else if (arg == "--verbose") {
+      opts.verbose = true;
+      opts.config.noSerialLogging = false;
+    } else {
+      usage(argv[0]);
+    }
+  }
+  if (opts.nodes <= 0 || opts.associationMin < 0 ||
+      opts.associationMax < opts.associationMin)
+    usage(argv[0]);
+  opts.config.baseURL = opts.baseURL;
+  return opts;
+}
+
+uint32_t provisioningRetries(SHI::ESP32HW *hw) {
+  for (auto &&stat : hw->getStatistics()) {
+    if (stat.first == "provisioningRetries") return atoi(stat.second.c_str());
+  }
+  return 0;
+}
+
+void runNode(int id, const Options &opts, NodeResult *result) {
+  sim::Node node;
+  node.id = id;
+  char mac[18];
+  snprintf(mac, sizeof(mac), "24:0A:C4:%02X:%02X:%02X", (id >> 16) & 0xFF,
+           (id >> 8) & 0xFF, id & 0xFF);
+  node.mac = mac;
+  node.rng.seed(opts.seed * 7919 + id);
+  sim::node = &node;
+
+  uint32_t powerOn = millis();
+  delay(random(0, opts.bootJitter + 1));
+  for (int boot = 0; boot <= opts.maxRestarts; boot++) {
+    WiFi.reset();
+    node.associationTime = random(opts.associationMin, opts.associationMax + 1);
+    std::unique_ptr<SHI::ESP32HW> hw(new SHI::ESP32HW(opts.config));
+    try {
+      // Same paths as setup() in SHIESP32Bootup.cpp. The factory isn't run,
+      // it and SHI::hw are process wide, so the runtime file only decides
+      // which path the node takes.
+      if (SPIFFS.exists(RUNTIME_NAME)) {
+        hw->setup("RuntimeESP32");
+        result->ready = true;
+        result->timeToReady = millis() - powerOn;
+      } else {
+        hw->setup("UnconfiguredESP32");
+        if (provisionRuntimeConfig(hw.get(), SPIFFS, RUNTIME_NAME)) {
+          hw->resetWithReason("Runtime config file written", true);
+        }
+      }
+      result->retries += provisioningRetries(hw.get());
+      return;
+    } catch (const sim::Restart &) {
+      result->restarts++;
+      result->retries += provisioningRetries(hw.get());
+    }
+  }
+}
+
+uint32_t percentile(const std::vector<uint32_t> &sorted, double p) {
+  if (sorted.empty()) return 0;
+  size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+void printDistribution(const char *title, std::vector<uint32_t> values) {
+  std::sort(values.begin(), values.end());
+  printf("%-22s min %6u  p50 %6u  p90 %6u  p99 %6u  max %6u\n", title,
+         percentile(values, 0), percentile(values, 0.5),
+         percentile(values, 0.9), percentile(values, 0.99),
+         percentile(values, 1));
+}
+
+void report(const Options &opts, const std::vector<NodeResult> &results,
+            uint32_t duration) {
+  int ready = 0, restarts = 0;
+  uint32_t retries = 0;
+  std::vector<uint32_t> timeToReady;
+  for (auto &&result : results) {
+    restarts += result.restarts;
+    retries += result.retries;
+    if (result.ready) {
+      ready++;
+      timeToReady.push_back(result.timeToReady);
+    }
+  }
+  std::map<int, int> codes;
+  std::vector<uint32_t> latencies, starts;
+  for (auto &&request : requests) {
+    codes[request.httpCode]++;
+    latencies.push_back(request.latency);
+    starts.push_back(request.start);
+  }
+  // Peak is the most requests started within any one second window, the
+  // average spreads them over as many seconds as the requests span
+  std::sort(starts.begin(), starts.end());
+  size_t peak = 0;
+  for (size_t begin = 0, end = 0; end < starts.size(); end++) {
+    while (starts[end] - starts[begin] >= 1000) begin++;
+    peak = std::max(peak, end - begin + 1);
+  }
+  uint32_t seconds =
+      starts.empty() ? 1 : (starts.back() - starts.front()) / 1000 + 1;
+
+  printf("Nodes:                 %d ready, %d not ready, %d restarts\n", ready,
+         opts.nodes - ready, restarts);
+  printf("Duration:              %u ms\n", duration);
+  printf("Requests:              %zu (%u retries)\n", requests.size(), retries);
+  for (auto &&code : codes) {
+    printf("  %4d %-16s %d\n", code.first,
+           code.first < 0 ? HTTPClient::errorToString(code.first).c_str() : "",
+           code.second);
+  }
+  printf("Request rate:          %.1f/s average, %zu/s peak\n",
+         static_cast<double>(requests.size()) / seconds, peak);
+  printDistribution("Request latency ms:", latencies);
+  printDistribution("Time to ready ms:", timeToReady);
+}
+
+}  // namespace
+
+void sim::recordRequest(uint32_t start, uint32_t latency, int httpCode) {
+  std::lock_guard<std::mutex> lock(requestMutex);
+  requests.push_back({start, latency, httpCode});
+}
+
+int main(int argc, char **argv) {
+  Options opts = parseOptions(argc, argv);
+  // The logging macros go through SHI::hw, give them an instance that lives
+  // as long as the simulation
+  SHI::ESP32HW logger(opts.config);
+  SHI::hw = &logger;
+
+  printf("Booting %d nodes against %s\n", opts.nodes, opts.baseURL.c_str());
+  std::vector<NodeResult> results(opts.nodes);
+  std::vector<std::thread> threads;
+  uint32_t start = millis();
+  for (int i = 0; i < opts.nodes; i++) {
+    threads.emplace_back(runNode, i, std::cref(opts), &results[i]);
+  }
+  for (auto &&thread : threads) thread.join();
+  report(opts, results, millis() - start);
+  return 0;
+}
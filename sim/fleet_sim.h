@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2020 Karsten Becker All rights reserved.
+ * Use of this source code is governed by a BSD-style
+ * license that can be found in the LICENSE file.
+ */
+#pragma once
+#include <stdint.h>
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace sim {
+
+// Thrown by ESP.restart(), the node's thread catches it and boots again
+struct Restart {};
+
+// State of a simulated device that outlives a restart
+struct Node {
+  int id = 0;
+  std::string mac;
+  std::mt19937 rng;
+  uint32_t associationTime = 0;  // ms until WiFi.begin() connects
+  uint32_t cpuFrequency = 240;
+  std::map<std::string, std::vector<uint8_t>> nvs;
+  std::map<std::string, std::string> files;  // SPIFFS content by path
+};
+
+// The node simulated by the calling thread
+extern thread_local Node *node;
+
+void recordRequest(uint32_t start, uint32_t latency, int httpCode);
+
+}  // namespace sim
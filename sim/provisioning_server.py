@@ -0,0 +1,78 @@
+"""Stand-in for the provisioning server, for use with the fleet simulator.
+
+Answers the MAC lookup (<prefix><MAC>) with a node name and <prefix><name>.json
+with an empty runtime config. --latency and --max-concurrent emulate a slow
+server that starts rejecting requests with 503 when too many arrive at once.
+"""
+from __future__ import print_function
+import argparse
+import threading
+import time
+
+try:
+    from http.server import BaseHTTPRequestHandler, HTTPServer
+    from socketserver import ThreadingMixIn
+except ImportError:
+    from BaseHTTPServer import BaseHTTPRequestHandler, HTTPServer
+    from SocketServer import ThreadingMixIn
+
+
+class ProvisioningServer(ThreadingMixIn, HTTPServer):
+    daemon_threads = True
+
+    def __init__(self, address, args):
+        self.request_queue_size = args.backlog
+        HTTPServer.__init__(self, address, ProvisioningHandler)
+        self.args = args
+        self.slots = threading.BoundedSemaphore(args.max_concurrent)
+
+
+class ProvisioningHandler(BaseHTTPRequestHandler):
+    def do_GET(self):
+        server = self.server
+        if not self.path.startswith(server.args.prefix):
+            self.reply(404, "")
+            return
+        if not server.slots.acquire(False):
+            self.reply(503, "")
+            return
+        try:
+            time.sleep(server.args.latency / 1000.0)
+            resource = self.path[len(server.args.prefix):]
+            if resource.endswith(".json"):
+                self.reply(200, "{}")
+            else:
+                self.reply(200, "node-" + resource.replace("_", "")[-6:] + "\n")
+        finally:
+            server.slots.release()
+
+    def reply(self, code, body):
+        data = body.encode("utf-8")
+        self.send_response(code)
+        self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def log_message(self, format, *args):
+        if self.server.args.verbose:
+            BaseHTTPRequestHandler.log_message(self, format, *args)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--prefix", default="/esp/")
+    parser.add_argument("--latency", type=int, default=20,
+                        help="service time per request in ms")
+    parser.add_argument("--max-concurrent", type=int, default=1000,
+                        help="requests served at once, the rest get 503")
+    parser.add_argument("--backlog", type=int, default=128)
+    parser.add_argument("--verbose", action="store_true")
+    args = parser.parse_args()
+    server = ProvisioningServer(("127.0.0.1", args.port), args)
+    print("Serving {} on port {}".format(args.prefix, args.port))
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
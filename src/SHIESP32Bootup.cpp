@@ -4,7 +4,6 @@
  * license that can be found in the LICENSE file.
  */
 #include <Arduino.h>
-#include <HTTPClient.h>
 #include <SHIESP32HW.h>
 #include <SHIHardware.h>
 #include <SPIFFS.h>
@@ -29,24 +28,9 @@ void setup() {
     SHI::hw->setup("UnconfiguredESP32");
     SHI_LOGINFO(
         "Bootup success from bootstrap file, trying to load runtime config");
-    HTTPClient http;
-    auto hwConfig = SHI::hw->getConfigAs<SHI::ESP32HWConfig>();
-    String url = String(hwConfig.baseURL.c_str()) +
-                 SHI::hw->getNodeName().c_str() + ".json";
-    http.begin(url);
-    http.setConnectTimeout(hwConfig.CONNECT_TIMEOUT);
-    http.setTimeout(hwConfig.DATA_TIMEOUT);
-    int httpCode = http.GET();
-    if (httpCode == 200) {
-      String newConfig = http.getString();
-      if (writeConfigFile(SPIFFS, RUNTIME_NAME, newConfig)) {
-        SHI::hw->resetWithReason("Runtime config file written", true);
-      }
-    } else {
-      String msg = String("Failed to load runtime config from:") + url +
-                   " Error was: " + String(httpCode) + " " +
-                   http.errorToString(httpCode);
-      SHI_LOGWARN(msg.c_str());
+    if (provisionRuntimeConfig(static_cast<SHI::ESP32HW *>(SHI::hw), SPIFFS,
+                               RUNTIME_NAME)) {
+      SHI::hw->resetWithReason("Runtime config file written", true);
     }
   } else {
     ets_printf("Bootstrapping failed with code:%d (%s)\n", error,
@@ -10,6 +10,7 @@
 #include <HTTPClient.h>
 #include <Preferences.h>
 #include <WiFi.h>
+#include <lwip/dns.h>
 #include <rom/rtc.h>
 #include <time.h>
 
@@ -57,6 +58,8 @@ const String internalVersion = String(SHI::MAJOR_VERSION, 10) + "." +
                                String(SHI::PATCH_VERSION, 10);
 const char *SHI::VERSION = internalVersion.c_str();
 
+const uint32_t SHI::ESP32HW::CPU_FREQUENCIES[] = {240, 160, 80};
+
 void SHI::ESP32HW::errLeds(void) {
   // Set pin mode
   if (hwConfig.ERR_LED != -1) {
@@ -78,9 +81,79 @@ void SHI::ESP32HW::loop() {
   internalLoop();
   uint32_t diff = millis() - start;
   averageSensorLoopDuration = ((averageSensorLoopDuration * 9) + diff) / 10.;
+  governCpuFrequency(diff);
   if (diff < 1000) delay(diff);
 }
 
+uint32_t SHI::ESP32HW::cpuFrequencyOfLevel(size_t level) {
+  return level < CPU_LEVELS ? CPU_FREQUENCIES[level] : bootFrequency;
+}
+
+void SHI::ESP32HW::setCpuFrequencyLevel(size_t level) {
+  uint32_t now = millis();
+  timeAtFrequency[cpuLevel] += now - lastFrequencyChange;
+  lastFrequencyChange = now;
+  if (level == cpuLevel) return;
+  if (!setCpuFrequencyMhz(cpuFrequencyOfLevel(level))) {
+    SHI_LOGWARN("Failed to set CPU frequency to " +
+                std::string(String(cpuFrequencyOfLevel(level)).c_str()));
+    return;
+  }
+  cpuLevel = level;
+  frequencyChanges++;
+}
+
+void SHI::ESP32HW::boostCpu(uint32_t durationMs) {
+  if (hwConfig.cpuGovernor) startBoost(durationMs);
+}
+
+void SHI::ESP32HW::startBoost(uint32_t durationMs) {
+  boostUntil = millis() + durationMs;
+  if (boostUntil == 0) boostUntil = 1;
+  setCpuFrequencyLevel(0);
+}
+
+void SHI::ESP32HW::governCpuFrequency(uint32_t loopDuration) {
+  if (hwConfig.loopDeadline <= 0) return;
+  bool missedDeadline = loopDuration > (uint32_t)hwConfig.loopDeadline;
+  if (missedDeadline) deadlineMisses++;
+  if (!hwConfig.cpuGovernor) return;
+  if (boostUntil != 0) {
+    if ((int32_t)(millis() - boostUntil) < 0) return;
+    boostUntil = 0;
+  }
+  if (missedDeadline) {
+    lowLoadCount = 0;
+    setCpuFrequencyLevel(0);
+    return;
+  }
+  float utilization = loopDuration / static_cast<float>(hwConfig.loopDeadline);
+  if (utilization > 0.75) {
+    lowLoadCount = 0;
+    if (cpuLevel > 0) setCpuFrequencyLevel(cpuLevel - 1);
+    return;
+  }
+  size_t lower = cpuLevel + 1;
+  if (lower >= CPU_LEVELS ||
+      CPU_FREQUENCIES[lower] < (uint32_t)hwConfig.minCpuFrequency) {
+    lowLoadCount = 0;
+    return;
+  }
+  // Estimate the utilization at the next lower frequency and only step down
+  // if there is still plenty of slack left, and only after a couple of loops
+  // to avoid oscillating between two levels
+  float expected =
+      utilization * CPU_FREQUENCIES[cpuLevel] / CPU_FREQUENCIES[lower];
+  if (expected < 0.5) {
+    if (++lowLoadCount >= 10) {
+      lowLoadCount = 0;
+      setCpuFrequencyLevel(lower);
+    }
+  } else {
+    lowLoadCount = 0;
+  }
+}
+
 void SHI::ESP32HW::setupWatchdog() {
   timer = timerBegin(0, 80, true);                            // timer 0, div 80
   timerAttachInterrupt(timer, &resetModule, true);            // attach callback
@@ -125,14 +198,62 @@ void SHI::ESP32HW::printConfig() {
   SHI_LOGINFO("Reset reason:" + std::string(config.resetReason));
 }
 
+void SHI::ESP32HW::provisioningDelay(uint32_t maxDelay) {
+  uint32_t remaining = random(0, maxDelay + 1);
+  // Sleep in chunks so the watchdog doesn't trigger on long backoffs
+  while (remaining > 0) {
+    uint32_t chunk = remaining < 1000 ? remaining : 1000;
+    delay(chunk);
+    remaining -= chunk;
+    feedWatchdog();
+  }
+}
+
+int SHI::ESP32HW::provisioningGet(HTTPClient &http, const String &url) {
+  uint32_t start = millis();
+  if (!provisioningSpread && hwConfig.provisioningStartSpread > 0)
+    provisioningDelay(hwConfig.provisioningStartSpread);
+  provisioningSpread = true;
+  int attempts =
+      hwConfig.provisioningAttempts > 0 ? hwConfig.provisioningAttempts : 1;
+  int httpCode = 0;
+  for (int attempt = 0; attempt < attempts; attempt++) {
+    if (attempt > 0) {
+      provisioningRetries++;
+      uint32_t maxBackoff = hwConfig.provisioningMaxBackoff;
+      uint32_t backoff = hwConfig.provisioningBackoff;
+      for (int i = 0; i < attempt - 1 && backoff < maxBackoff; i++)
+        backoff *= 2;
+      if (backoff > maxBackoff) backoff = maxBackoff;
+      SHI_LOGINFO("Provisioning request failed with " +
+                  std::string(String(httpCode).c_str()) + ", retrying in <" +
+                  std::string(String(backoff).c_str()) + "ms");
+      http.end();
+      provisioningDelay(backoff);
+    }
+    provisioningRequests++;
+    http.begin(url);
+    http.setConnectTimeout(hwConfig.CONNECT_TIMEOUT);
+    http.setTimeout(hwConfig.DATA_TIMEOUT);
+    httpCode = http.GET();
+    feedWatchdog();
+    // Only retry when the server is unreachable or overloaded, anything else
+    // won't change by asking again
+    if (httpCode > 0 && httpCode < 500 && httpCode != 429) break;
+  }
+  provisioningTime += millis() - start;
+  return httpCode;
+}
+
+String SHI::ESP32HW::getRuntimeConfigURL() {
+  return String(hwConfig.baseURL.c_str()) + getNodeName().c_str() + ".json";
+}
+
 bool SHI::ESP32HW::updateNodeName() {
   HTTPClient http;
   String mac = WiFi.macAddress();
   mac.replace(':', '_');
-  http.begin(String(hwConfig.baseURL.c_str()) + mac);
-  http.setConnectTimeout(hwConfig.CONNECT_TIMEOUT);
-  http.setTimeout(hwConfig.DATA_TIMEOUT);
-  int httpCode = http.GET();
+  int httpCode = provisioningGet(http, String(hwConfig.baseURL.c_str()) + mac);
   if (httpCode == 200) {
     String newName = http.getString();
     newName.replace('\n', '\0');
@@ -220,23 +341,34 @@ void SHI::ESP32HW::initialWifiConnect() {
   wifiConnected();
 }
 
+void SHI::ESP32HW::storeWifiAddress() {
+  config.local_IP = WiFi.localIP();
+  config.gateway = WiFi.gatewayIP();
+  config.subnet = WiFi.subnetMask();
+  config.canary = CONST_MARKER;
+  configPrefs.putBytes(CONFIG, &config, sizeof(config_t));
+}
+
 void SHI::ESP32HW::storeWifiConfig() {
   if (config.canary != CONST_MARKER && updateNodeName()) {
     SHI_LOGINFO("Storing config");
-    config.local_IP = WiFi.localIP();
-    config.gateway = WiFi.gatewayIP();
-    config.subnet = WiFi.subnetMask();
     // config.name is set by updateNodeName
     WiFi.setHostname(config.name);
     resetWithReason("Fresh-reset", false);
-    config.canary = CONST_MARKER;
-    configPrefs.putBytes(CONFIG, &config, sizeof(config_t));
+    storeWifiAddress();
     SHI_LOGINFO("ESP Mac Address: " + std::string(WiFi.macAddress().c_str()));
     printConfig();
   }
 }
 
 void SHI::ESP32HW::setup(const std::string &defaultName) {
+  bootFrequency = getCpuFrequencyMhz();
+  cpuLevel = CPU_LEVELS;
+  for (size_t i = 0; i < CPU_LEVELS; i++) {
+    if (CPU_FREQUENCIES[i] == bootFrequency) cpuLevel = i;
+  }
+  bootLevel = cpuLevel;
+  lastFrequencyChange = millis();
   setupWatchdog();
   feedWatchdog();
 
@@ -245,8 +377,8 @@ void SHI::ESP32HW::setup(const std::string &defaultName) {
 
   uint32_t intialWifiConnectStart = millis();
   initialWifiConnect();
-  storeWifiConfig();
   initialWifiConnectTime = millis() - intialWifiConnectStart;
+  storeWifiConfig();
   statusMessage =
       std::string("STARTED: ") + RESET_SOURCE[rtc_get_reset_reason(0)] + ":" +
       RESET_SOURCE[rtc_get_reset_reason(1)] + " " + config.resetReason;
@@ -274,6 +406,18 @@ int64_t SHI::ESP32HW::getEpochInMs() {
 }
 
 bool SHI::ESP32HW::wifiIsConntected() {
+  if (reconnectDeadline != 0) {
+    // A reconfiguration switched the network, give the association some time
+    // before treating it as a lost connection
+    if (WiFi.status() == WL_CONNECTED) {
+      reconnectDeadline = 0;
+      applyDNS();
+      storeWifiAddress();
+      return true;
+    }
+    if ((int32_t)(millis() - reconnectDeadline) < 0) return false;
+    reconnectDeadline = 0;
+  }
   uint32_t start = millis();
   while (WiFi.status() != WL_CONNECTED) {
     feedWatchdog();
@@ -287,6 +431,7 @@ bool SHI::ESP32HW::wifiIsConntected() {
     WiFi.mode(WIFI_STA);
     WiFi.begin(hwConfig.ssid.c_str(), hwConfig.password.c_str());
     retryCount++;
+    boostCpu(retryCount * 1000 + hwConfig.reconnectDelay);
     delay(retryCount * 1000);
   }
   uint32_t diff = millis() - start;
@@ -296,6 +441,7 @@ bool SHI::ESP32HW::wifiIsConntected() {
 }
 
 std::vector<std::pair<std::string, std::string>> SHI::ESP32HW::getStatistics() {
+  setCpuFrequencyLevel(cpuLevel);
   return {
       {"connectCount", String(connectCount).c_str()},
       {"retryCount", String(retryCount).c_str()},
@@ -304,5 +450,110 @@ std::vector<std::pair<std::string, std::string>> SHI::ESP32HW::getStatistics() {
       {"sensorSetupTime", String(sensorSetupTime).c_str()},
       {"averageSensorLoopDuration", String(averageSensorLoopDuration).c_str()},
       {"averageConnectDuration", String(averageConnectDuration).c_str()},
+      {"cpuFrequency", String(getCpuFrequencyMhz()).c_str()},
+      {"timeAt240MHz", String(timeAtFrequency[0]).c_str()},
+      {"timeAt160MHz", String(timeAtFrequency[1]).c_str()},
+      {"timeAt80MHz", String(timeAtFrequency[2]).c_str()},
+      {"timeAtBootFrequency", String(timeAtFrequency[CPU_LEVELS]).c_str()},
+      {"cpuFrequencyChanges", String(frequencyChanges).c_str()},
+      {"deadlineMisses", String(deadlineMisses).c_str()},
+      {"provisioningRequests", String(provisioningRequests).c_str()},
+      {"provisioningRetries", String(provisioningRetries).c_str()},
+      {"provisioningTime", String(provisioningTime).c_str()},
   };
 }
+
+void SHI::ESP32HW::reconfigureLogging(const ESP32HWConfig &newConfig) {
+  if (newConfig.noSerialLogging == hwConfig.noSerialLogging &&
+      newConfig.baudRate == hwConfig.baudRate)
+    return;
+  debugSerial->flush();
+  if (newConfig.noSerialLogging != hwConfig.noSerialLogging) {
+    delete debugSerial;
+    if (newConfig.noSerialLogging) {
+      debugSerial = new NullSHIPrinter();
+    } else {
+      debugSerial = new HardwareSHIPrinter();
+    }
+  }
+  debugSerial->begin(newConfig.baudRate);
+}
+
+void SHI::ESP32HW::applyDNS() {
+  IPAddress primaryDNS;
+  IPAddress secondaryDNS;
+  ip_addr_t dns;
+  dns.type = IPADDR_TYPE_V4;
+  // Set the servers directly in lwip, WiFi.config would pin the current
+  // (possibly DHCP) address as static IP
+  if (primaryDNS.fromString(hwConfig.primaryDNS.c_str())) {
+    dns.u_addr.ip4.addr = static_cast<uint32_t>(primaryDNS);
+    dns_setserver(0, &dns);
+  }
+  if (secondaryDNS.fromString(hwConfig.secondaryDNS.c_str())) {
+    dns.u_addr.ip4.addr = static_cast<uint32_t>(secondaryDNS);
+    dns_setserver(1, &dns);
+  }
+}
+
+void SHI::ESP32HW::reconfigureWifi(const ESP32HWConfig &newConfig) {
+  bool credentialsChanged = newConfig.ssid != hwConfig.ssid ||
+                            newConfig.password != hwConfig.password;
+  bool dnsChanged = newConfig.primaryDNS != hwConfig.primaryDNS ||
+                    newConfig.secondaryDNS != hwConfig.secondaryDNS;
+  if (credentialsChanged) {
+    SHI_LOGINFO("Wifi credentials changed, reconnecting to " + newConfig.ssid);
+    // The stored addressing belongs to the old network, fall back to DHCP and
+    // let storeWifiAddress() learn the new one once connected. DNS is applied
+    // after the reconnect.
+    config.canary = 0;
+    configPrefs.putBytes(CONFIG, &config, sizeof(config_t));
+    WiFi.disconnect();
+    WiFi.config(0u, 0u, 0u);
+    WiFi.begin(newConfig.ssid.c_str(), newConfig.password.c_str());
+    reconnectDeadline =
+        millis() + newConfig.reconnectDelay * newConfig.reconnectAttempts;
+    if (reconnectDeadline == 0) reconnectDeadline = 1;
+    if (newConfig.cpuGovernor)
+      startBoost(reconnectDeadline - millis() + newConfig.reconnectDelay);
+  } else if (dnsChanged) {
+    hwConfig.primaryDNS = newConfig.primaryDNS;
+    hwConfig.secondaryDNS = newConfig.secondaryDNS;
+    applyDNS();
+  }
+}
+
+bool SHI::ESP32HW::reconfigure(Configuration *newConfig) {
+  auto newHwConfig = castConfig<ESP32HWConfig>(newConfig);
+  if (newHwConfig.wdtTimeout <= 0) {
+    SHI_LOGERROR("Invalid wdtTimeout " +
+                 std::string(String(newHwConfig.wdtTimeout).c_str()));
+    return false;
+  }
+  if (hwConfig.cpuGovernor && !newHwConfig.cpuGovernor) {
+    boostUntil = 0;
+    setCpuFrequencyLevel(bootLevel);
+  } else if (newHwConfig.cpuGovernor) {
+    startBoost(newHwConfig.loopDeadline);
+  }
+  // Only apply what actually changed, everything else (timeouts, baseURL,
+  // debugLevel etc.) is read from hwConfig on use
+  reconfigureLogging(newHwConfig);
+  if (timer != NULL && newHwConfig.wdtTimeout != hwConfig.wdtTimeout) {
+    feedWatchdog();
+    timerAlarmWrite(timer, newHwConfig.wdtTimeout * 1000, false);
+  }
+  if (newHwConfig.ntpServer != hwConfig.ntpServer ||
+      newHwConfig.gmtOffset_sec != hwConfig.gmtOffset_sec ||
+      newHwConfig.daylightOffset_sec != hwConfig.daylightOffset_sec) {
+    configTime(newHwConfig.gmtOffset_sec, newHwConfig.daylightOffset_sec,
+               newHwConfig.ntpServer.c_str());
+  }
+  reconfigureWifi(newHwConfig);
+  if (newHwConfig.ERR_LED != hwConfig.ERR_LED && hwConfig.ERR_LED != -1) {
+    digitalWrite(hwConfig.ERR_LED, LOW);
+  }
+  hwConfig = newHwConfig;
+  feedWatchdog();
+  return true;
+}
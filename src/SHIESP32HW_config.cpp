@@ -41,7 +41,14 @@ SHI::ESP32HWConfig::ESP32HWConfig(const JsonObject &obj):
       ERR_LED(obj["ERR_LED"] | BUILTIN_LED),
       baudRate(obj["baudRate"] | 115200),
       noSerialLogging(obj["noSerialLogging"] | false),
-      debugLevel(obj["debugLevel"] | 0)
+      debugLevel(obj["debugLevel"] | 0),
+      cpuGovernor(obj["cpuGovernor"] | false),
+      loopDeadline(obj["loopDeadline"] | 1000),
+      minCpuFrequency(obj["minCpuFrequency"] | 80),
+      provisioningAttempts(obj["provisioningAttempts"] | 5),
+      provisioningStartSpread(obj["provisioningStartSpread"] | 10000),
+      provisioningBackoff(obj["provisioningBackoff"] | 500),
+      provisioningMaxBackoff(obj["provisioningMaxBackoff"] | 30000)
   {}
 
 void SHI::ESP32HWConfig::fillData(JsonObject &doc) const {
@@ -67,9 +74,16 @@ void SHI::ESP32HWConfig::fillData(JsonObject &doc) const {
   doc["baudRate"] = baudRate;
   doc["noSerialLogging"] = noSerialLogging;
   doc["debugLevel"] = debugLevel;
+  doc["cpuGovernor"] = cpuGovernor;
+  doc["loopDeadline"] = loopDeadline;
+  doc["minCpuFrequency"] = minCpuFrequency;
+  doc["provisioningAttempts"] = provisioningAttempts;
+  doc["provisioningStartSpread"] = provisioningStartSpread;
+  doc["provisioningBackoff"] = provisioningBackoff;
+  doc["provisioningMaxBackoff"] = provisioningMaxBackoff;
 }
 
 int SHI::ESP32HWConfig::getExpectedCapacity() const {
-  return JSON_OBJECT_SIZE(22);
+  return JSON_OBJECT_SIZE(29);
 }
 
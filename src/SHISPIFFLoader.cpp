@@ -6,6 +6,7 @@
 #include "SHISPIFFLoader.h"
 
 #include <ArduinoJson.h>
+#include <HTTPClient.h>
 #include <SHIFactory.h>
 #include <SPIFFS.h>
 
@@ -46,4 +47,20 @@ bool writeConfigFile(const FS &fs, const char *filename, String content) {
     return false;
   }
   file.close();
+  return true;
+}
+
+bool provisionRuntimeConfig(SHI::ESP32HW *hw, const FS &fs,
+                            const char *filename) {
+  HTTPClient http;
+  String url = hw->getRuntimeConfigURL();
+  int httpCode = hw->provisioningGet(http, url);
+  if (httpCode == 200) {
+    return writeConfigFile(fs, filename, http.getString());
+  }
+  String msg = String("Failed to load runtime config from:") + url +
+               " Error was: " + String(httpCode) + " " +
+               http.errorToString(httpCode);
+  SHI_LOGWARN(msg.c_str());
+  return false;
 }